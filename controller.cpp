@@ -1,16 +1,23 @@
+#include <QCborMap>
+#include <QCborStreamWriter>
+#include <QCborValue>
 #include "devices/nobby.h"
 #include "controller.h"
 #include "logger.h"
 
-Controller::Controller(const QString &configFile) : HOMEd(SERVICE_VERSION, configFile), m_status(false), m_names(false)
+Controller::Controller(const QString &configFile) : HOMEd(SERVICE_VERSION, configFile), m_client(findChild <QMqttClient*> (QString(), Qt::FindDirectChildrenOnly)), m_status(false), m_names(false)
 {
     QList <QString> names = getConfig()->childGroups(), types = {"nobbyBalance"};
+    QMap <QString, Device> devices;
+
+    if (getConfig()->value("watchdog/enabled", false).toBool())
+        connect(new Watchdog(getConfig()->value("watchdog/threshold", WATCHDOG_THRESHOLD).toInt(), this), &Watchdog::stallDetected, this, &Controller::stallDetected);
 
     for (int i = 0; i < names.count(); i++)
     {
         const QString &name = names.at(i);
 
-        if (name != "log" && name != "mqtt")
+        if (name != "log" && name != "mqtt" && name != "watchdog" && name != "groups")
         {
             QString port = getConfig()->value(QString("%1/port").arg(name), "/dev/ttyUSB0").toString();
             bool debug = getConfig()->value(QString("%1/debug").arg(name), false).toBool();
@@ -25,26 +32,122 @@ Controller::Controller(const QString &configFile) : HOMEd(SERVICE_VERSION, confi
                 default: continue;
             }
 
+            device->setBinary(getConfig()->value(QString("%1/encoding").arg(name), "json").toString() == "cbor");
+
             connect(device.data(), &DeviceObject::availabilityUpdated, this, &Controller::availabilityUpdated);
             connect(device.data(), &DeviceObject::propertiesUpdated, this, &Controller::propertiesUpdated);
+            connect(device.data(), &DeviceObject::pollFinished, this, &Controller::pollFinished);
 
             m_devices.append(device);
+            devices.insert(name, device);
             device->init();
         }
     }
+
+    getConfig()->beginGroup("groups");
+    names = getConfig()->childKeys();
+
+    for (int i = 0; i < names.count(); i++)
+    {
+        const QString &name = names.at(i);
+        QList <QString> list = getConfig()->value(name).toStringList();
+        QList <Device> group;
+
+        for (int j = 0; j < list.count(); j++)
+        {
+            const Device &device = devices.value(list.at(j).trimmed());
+
+            if (device.isNull())
+            {
+                logWarning << "group" << name << "member" << list.at(j).trimmed() << "not found";
+                continue;
+            }
+
+            group.append(device);
+        }
+
+        if (!group.isEmpty())
+            m_groups.insert(name, group);
+    }
+
+    getConfig()->endGroup();
+
+    if (!m_client)
+        logWarning << "mqtt client not found, binary encoding disabled";
+}
+
+void Controller::mqttPublishBinary(const QString &topic, const QByteArray &payload, bool retain)
+{
+    if (!m_client || m_client->state() != QMqttClient::Connected)
+    {
+        logWarning << "mqtt client not available, binary message for" << topic << "dropped";
+        return;
+    }
+
+    m_client->publish(QMqttTopicName(topic), payload, 0, retain);
+}
+
+void Controller::publishStatus(DeviceObject *device, const QString &status)
+{
+    QString topic = mqttTopic("device/custom/%1").arg(m_names ? device->name() : device->id());
+
+    if (device->binary())
+    {
+        QByteArray payload;
+        QCborStreamWriter writer(&payload);
+
+        writer.startMap(1);
+        writer.append(QLatin1String("status"));
+        writer.append(status);
+        writer.endMap();
+
+        mqttPublishBinary(topic, payload, true);
+        return;
+    }
+
+    mqttPublish(topic, {{"status", status}}, true);
 }
 
 void Controller::publishAvailability(DeviceObject *device)
 {
     QString status = device->availability() == Availability::Online ? "online" : "offline";
-    mqttPublish(mqttTopic("device/custom/%1").arg(m_names ? device->name() : device->id()), {{"status", status}}, true);
+    publishStatus(device, status);
     logInfo << device << "is" << status;
 }
 
+void Controller::publishSnapshot(DeviceObject *device, bool timeout)
+{
+    mqttPublish(mqttTopic("response/custom/%1").arg(m_names ? device->name() : device->id()), {{"properties", QJsonObject::fromVariantMap(device->properties())}, {"age", device->age()}, {"timeout", timeout}});
+}
+
+void Controller::groupAction(const QString &group, const Device &device, const QJsonObject &json, const QSharedPointer <groupRequestStruct> &request)
+{
+    WatchdogScope scope(device->id(), "groupAction");
+    QString status = "offline";
+
+    if (device->availability() != Availability::Offline)
+    {
+        bool check = true;
+
+        for (auto it = json.begin(); it != json.end(); it++)
+            if (!device->action(it.key(), it.value().toVariant()))
+                check = false;
+
+        status = check ? "sent" : "failed";
+    }
+
+    request->devices.insert(m_names ? device->name() : device->id(), status);
+
+    if (--request->pending)
+        return;
+
+    mqttPublish(mqttTopic("response/custom/group/%1").arg(group), {{"devices", request->devices}});
+}
+
 void Controller::quit(void)
 {
     for (int i = 0; i < m_devices.count(); i++)
-        mqttPublish(mqttTopic("device/custom/%1").arg(m_names ? m_devices.at(i)->name() : m_devices.at(i)->id()), {{"status", "offline"}}, true);
+        publishStatus(m_devices.at(i).data(), "offline");
 
     HOMEd::quit();
 }
@@ -57,17 +160,25 @@ void Controller::mqttConnected(void)
 
 void Controller::mqttReceived(const QByteArray &message, const QMqttTopicName &topic)
 {
+    WatchdogScope scope("controller", "mqttReceived");
     QString subTopic = topic.name().replace(0, mqttTopic().length(), QString());
-    QJsonObject json = QJsonDocument::fromJson(message).object();
 
     if (subTopic == "service/custom")
     {
+        QJsonObject json = QJsonDocument::fromJson(message).object();
+
         if (json.value("status").toString() != "online")
         {
             m_status = false;
 
             for (int i = 0; i < m_devices.count(); i++)
+            {
                 mqttUnsubscribe(mqttTopic("td/custom/%1").arg(m_names ? m_devices.at(i)->name() : m_devices.at(i)->id()));
+                mqttUnsubscribe(mqttTopic("request/custom/%1").arg(m_names ? m_devices.at(i)->name() : m_devices.at(i)->id()));
+            }
+
+            for (auto it = m_groups.begin(); it != m_groups.end(); it++)
+                mqttUnsubscribe(mqttTopic("td/custom/group/%1").arg(it.key()));
 
             return;
         }
@@ -76,6 +187,7 @@ void Controller::mqttReceived(const QByteArray &message, const QMqttTopicName &t
     }
     else if (subTopic == "status/custom")
     {
+        QJsonObject json = QJsonDocument::fromJson(message).object();
         QJsonArray devices = json.value("devices").toArray();
 
         m_status = true;
@@ -101,6 +213,7 @@ void Controller::mqttReceived(const QByteArray &message, const QMqttTopicName &t
                 {
                     mqttPublish(mqttTopic("device/custom/%1").arg(device->name()), QJsonObject(), true);
                     mqttUnsubscribe(mqttTopic("td/custom/%1").arg(device->name()));
+                    mqttUnsubscribe(mqttTopic("request/custom/%1").arg(device->name()));
                     device->setName(name);
                 }
 
@@ -109,6 +222,7 @@ void Controller::mqttReceived(const QByteArray &message, const QMqttTopicName &t
             }
 
             mqttSubscribe(mqttTopic("td/custom/%1").arg(m_names ? device->name() : device->id()));
+            mqttSubscribe(mqttTopic("request/custom/%1").arg(m_names ? device->name() : device->id()));
 
             if (!check)
                 device->setPublished();
@@ -121,6 +235,27 @@ void Controller::mqttReceived(const QByteArray &message, const QMqttTopicName &t
 
             publishAvailability(device.data());
         }
+
+        for (auto it = m_groups.begin(); it != m_groups.end(); it++)
+            mqttSubscribe(mqttTopic("td/custom/group/%1").arg(it.key()));
+    }
+    else if (subTopic.startsWith("td/custom/group/"))
+    {
+        QString group = subTopic.split('/').last();
+        QJsonObject json = QJsonDocument::fromJson(message).object();
+        QList <Device> devices = m_groups.value(group);
+        QSharedPointer <groupRequestStruct> request(new groupRequestStruct);
+
+        if (devices.isEmpty() || json.isEmpty())
+            return;
+
+        request->pending = devices.count();
+
+        for (int i = 0; i < devices.count(); i++)
+        {
+            const Device &device = devices.at(i);
+            QTimer::singleShot(i * GROUP_PACING_INTERVAL, this, [this, group, device, json, request] () { groupAction(group, device, json, request); });
+        }
     }
     else if (subTopic.startsWith("td/custom/"))
     {
@@ -129,16 +264,75 @@ void Controller::mqttReceived(const QByteArray &message, const QMqttTopicName &t
         for (int i = 0; i < m_devices.count(); i++)
         {
             const Device &device = m_devices.at(i);
+            QJsonObject json;
 
             if ((m_names ? device->name() : device->id()) != string)
                 continue;
 
+            WatchdogScope scope(device->id(), "action");
+
+            if (device->binary() && !message.startsWith('{'))
+            {
+                QCborParserError error;
+                QCborValue value = QCborValue::fromCbor(message, &error);
+                QCborMap map = value.toMap();
+
+                if (error.error != QCborError::NoError || !value.isMap())
+                {
+                    logWarning << device << "command decoding failed:" << error.errorString();
+                    break;
+                }
+
+                for (auto it = map.begin(); it != map.end(); it++)
+                    device->action(it.key().toString(), it.value().toVariant());
+
+                break;
+            }
+
+            json = QJsonDocument::fromJson(message).object();
+
+            if (device->binary() && json.isEmpty())
+            {
+                logWarning << device << "command decoding failed";
+                break;
+            }
+
             for (auto it = json.begin(); it != json.end(); it++)
                 device->action(it.key(), it.value().toVariant());
 
             break;
         }
     }
+    else if (subTopic.startsWith("request/custom/"))
+    {
+        QString string = subTopic.split('/').last();
+        QJsonObject json = QJsonDocument::fromJson(message).object();
+
+        for (int i = 0; i < m_devices.count(); i++)
+        {
+            const Device &device = m_devices.at(i);
+            qint64 age;
+
+            if ((m_names ? device->name() : device->id()) != string)
+                continue;
+
+            age = device->age();
+
+            if (json.contains("maxAge"))
+            {
+                if (age < 0 || age > static_cast <qint64> (json.value("maxAge").toDouble()))
+                {
+                    device->poll();
+                    break;
+                }
+            }
+            else if (device->polling())
+                break;
+
+            publishSnapshot(device.data());
+            break;
+        }
+    }
 }
 
 void Controller::availabilityUpdated(void)
@@ -152,5 +346,70 @@ void Controller::availabilityUpdated(void)
 void Controller::propertiesUpdated(void)
 {
     DeviceObject *device = reinterpret_cast <DeviceObject*> (sender());
-    mqttPublish(mqttTopic("fd/custom/%1").arg(m_names ? device->name() : device->id()), QJsonObject::fromVariantMap(device->properties()));
+    WatchdogScope scope(device->id(), "propertiesUpdated");
+    QString topic = mqttTopic("fd/custom/%1").arg(m_names ? device->name() : device->id());
+
+    if (device->binary())
+    {
+        const QMap <QString, QVariant> &properties = device->properties();
+        QByteArray payload;
+        QCborStreamWriter writer(&payload);
+
+        writer.startMap(properties.count());
+
+        for (auto it = properties.begin(); it != properties.end(); it++)
+        {
+            writer.append(it.key());
+
+            switch (it.value().userType())
+            {
+                case QMetaType::Bool:      writer.append(it.value().toBool()); break;
+                case QMetaType::Double:    writer.append(it.value().toDouble()); break;
+                case QMetaType::QString:   writer.append(it.value().toString()); break;
+
+                case QMetaType::Char:
+                case QMetaType::SChar:
+                case QMetaType::Short:
+                case QMetaType::Int:
+                case QMetaType::Long:
+                case QMetaType::LongLong:  writer.append(it.value().toLongLong()); break;
+
+                case QMetaType::UChar:
+                case QMetaType::UShort:
+                case QMetaType::UInt:
+                case QMetaType::ULong:
+                case QMetaType::ULongLong: writer.append(it.value().toULongLong()); break;
+
+                default:                   QCborValue::fromVariant(it.value()).toCbor(writer); break;
+            }
+        }
+
+        writer.endMap();
+        mqttPublishBinary(topic, payload);
+        return;
+    }
+
+    mqttPublish(topic, QJsonObject::fromVariantMap(device->properties()));
+}
+
+void Controller::pollFinished(bool timeout)
+{
+    publishSnapshot(reinterpret_cast <DeviceObject*> (sender()), timeout);
+}
+
+void Controller::stallDetected(const QString &id, const QString &slot, qint64 duration, qint64 latency)
+{
+    QJsonObject json = {{"latency", latency}};
+
+    if (!slot.isEmpty())
+    {
+        json.insert("device", id);
+        json.insert("slot", slot);
+        json.insert("duration", duration);
+        logWarning << "event loop stalled for" << latency << "ms in" << id << slot << "handler running for" << duration << "ms";
+    }
+    else
+        logWarning << "event loop stalled for" << latency << "ms in unknown handler";
+
+    mqttPublish(mqttTopic("event/custom/watchdog"), json);
 }
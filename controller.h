@@ -1,10 +1,19 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
-#define SERVICE_VERSION     "1.0.6"
+#define SERVICE_VERSION             "1.0.6"
+#define GROUP_PACING_INTERVAL       100
 
+#include <QMqttClient>
 #include "device.h"
 #include "homed.h"
+#include "watchdog.h"
+
+struct groupRequestStruct
+{
+    QJsonObject devices;
+    int pending;
+};
 
 class Controller : public HOMEd
 {
@@ -16,10 +25,18 @@ public:
 
 private:
 
+    QMqttClient *m_client;
+
     bool m_status, m_names;
     QList <Device> m_devices;
+    QMap <QString, QList <Device>> m_groups;
+
+    void mqttPublishBinary(const QString &topic, const QByteArray &payload, bool retain = false);
 
+    void publishStatus(DeviceObject *device, const QString &status);
     void publishAvailability(DeviceObject *device);
+    void publishSnapshot(DeviceObject *device, bool timeout = false);
+    void groupAction(const QString &group, const Device &device, const QJsonObject &json, const QSharedPointer <groupRequestStruct> &request);
 
 public slots:
 
@@ -32,6 +49,9 @@ private slots:
 
     void availabilityUpdated(void);
     void propertiesUpdated(void);
+    void pollFinished(bool timeout);
+
+    void stallDetected(const QString &id, const QString &slot, qint64 duration, qint64 latency);
 
 };
 
@@ -1,6 +1,7 @@
 #include <netinet/tcp.h>
 #include "device.h"
 #include "logger.h"
+#include "watchdog.h"
 
 static uint8_t const crcTable[256] =
 {
@@ -22,7 +23,7 @@ static uint8_t const crcTable[256] =
     0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
 };
 
-DeviceObject::DeviceObject(quint8 appliance, const QString &port, const QString &id, bool debug) : QObject(nullptr), m_appliance(appliance), m_protocol(0), m_id(id), m_name(id), m_debug(debug), m_published(false), m_receiveTimer(new QTimer(this)), m_resetTimer(new QTimer(this)), m_updateTimer(new QTimer(this)), m_serial(new QSerialPort(this)), m_socket(new QTcpSocket(this)), m_serialError(false), m_connected(false), m_availability(Availability::Unknown)
+DeviceObject::DeviceObject(quint8 appliance, const QString &port, const QString &id, bool debug) : QObject(nullptr), m_appliance(appliance), m_protocol(0), m_id(id), m_name(id), m_debug(debug), m_published(false), m_binary(false), m_receiveTimer(new QTimer(this)), m_resetTimer(new QTimer(this)), m_updateTimer(new QTimer(this)), m_pollTimer(new QTimer(this)), m_serial(new QSerialPort(this)), m_socket(new QTcpSocket(this)), m_serialError(false), m_connected(false), m_availability(Availability::Unknown), m_updated(0)
 {
     if (!port.startsWith("tcp://"))
     {
@@ -52,9 +53,11 @@ DeviceObject::DeviceObject(quint8 appliance, const QString &port, const QString
     connect(m_receiveTimer, &QTimer::timeout, this, &DeviceObject::readyRead);
     connect(m_resetTimer, &QTimer::timeout, this, &DeviceObject::reset);
     connect(m_updateTimer, &QTimer::timeout, this, &DeviceObject::update);
+    connect(m_pollTimer, &QTimer::timeout, this, &DeviceObject::pollTimeout);
 
     m_receiveTimer->setSingleShot(true);
     m_resetTimer->setSingleShot(true);
+    m_pollTimer->setSingleShot(true);
 
     m_updateTimer->start(1000);
 }
@@ -67,6 +70,8 @@ DeviceObject::~DeviceObject(void)
 
 void DeviceObject::init(void)
 {
+    WatchdogScope scope(m_id, "init");
+
     if (m_device == m_serial)
     {
         if (m_serial->isOpen())
@@ -93,6 +98,16 @@ void DeviceObject::init(void)
     }
 }
 
+void DeviceObject::poll(void)
+{
+    if (m_pollTimer->isActive())
+        return;
+
+    logDebug(m_debug) << this << "poll";
+    m_pollTimer->start(POLL_TIMEOUT);
+    ping();
+}
+
 quint8 DeviceObject::checksum(const QByteArray &data)
 {
     quint8 checksum = 0;
@@ -122,8 +137,26 @@ void DeviceObject::updateAvailability(Availability availability)
     emit availabilityUpdated();
 }
 
+void DeviceObject::updateProperties(const QMap <QString, QVariant> &properties)
+{
+    m_updated = QDateTime::currentMSecsSinceEpoch();
+
+    if (m_properties != properties)
+    {
+        m_properties = properties;
+        emit propertiesUpdated();
+    }
+
+    if (!m_pollTimer->isActive())
+        return;
+
+    m_pollTimer->stop();
+    emit pollFinished(false);
+}
+
 void DeviceObject::sendFrame(quint8 type, const QByteArray &payload)
 {
+    WatchdogScope scope(m_id, "sendFrame");
     headerStruct header;
     QByteArray data;
 
@@ -188,6 +221,7 @@ void DeviceObject::startTimer(void)
 
 void DeviceObject::readyRead(void)
 {
+    WatchdogScope scope(m_id, "readyRead");
     QByteArray data = m_device->readAll();
 
     logDebug(m_debug) << this << "serial data received:" << data.toHex(':');
@@ -252,6 +286,7 @@ void DeviceObject::reset(void)
 
 void DeviceObject::update(void)
 {
+    WatchdogScope scope(m_id, "update");
     qint64 now = QDateTime::currentMSecsSinceEpoch();
 
     if (now > m_lastSeen + UNAVAILABLE_TIMEOUT)
@@ -263,3 +298,9 @@ void DeviceObject::update(void)
         ping();
     }
 }
+
+void DeviceObject::pollTimeout(void)
+{
+    logWarning << this << "poll timed out";
+    emit pollFinished(true);
+}
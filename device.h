@@ -6,6 +6,7 @@
 
 #define PING_TIMEOUT                5000
 #define UNAVAILABLE_TIMEOUT         15000
+#define POLL_TIMEOUT                2000
 
 #define START_BYTE                  0xAA
 #define BUFFER_LENGTH_LIMIT         1024
@@ -15,6 +16,7 @@
 #define FRAME_NOTIFY                0x04
 #define FRAME_NETWORK_QUERY         0x63
 
+#include <QDateTime>
 #include <QHostAddress>
 #include <QJsonArray>
 #include <QJsonObject>
@@ -51,13 +53,16 @@ public:
     DeviceObject(quint8 appliance, const QString &port, const QString &id, bool debug);
     ~DeviceObject(void);
 
-    virtual void action(const QString &name, const QVariant &data) = 0;
+    virtual bool action(const QString &name, const QVariant &data) = 0;
 
     inline QString id(void) { return m_id; }
 
     inline QString name(void) { return m_name; }
     inline void setName(const QString &value) { m_name = value; }
 
+    inline bool binary(void) { return m_binary; }
+    inline void setBinary(bool value) { m_binary = value; }
+
     inline Availability availability(void) { return m_availability; }
 
     inline bool published(void) { return m_published; }
@@ -67,16 +72,20 @@ public:
     inline QJsonObject options(void) { return m_options; }
     inline QMap <QString, QVariant> properties(void) { return m_properties; }
 
+    inline qint64 age(void) { return m_updated ? QDateTime::currentMSecsSinceEpoch() - m_updated : -1; }
+    inline bool polling(void) { return m_pollTimer->isActive(); }
+
     void init(void);
+    void poll(void);
 
 protected:
 
     quint8 m_appliance, m_protocol;
 
     QString m_id, m_name;
-    bool m_debug, m_published;
+    bool m_debug, m_published, m_binary;
 
-    QTimer *m_receiveTimer, *m_resetTimer, *m_updateTimer;
+    QTimer *m_receiveTimer, *m_resetTimer, *m_updateTimer, *m_pollTimer;
 
     QSerialPort *m_serial;
     QTcpSocket *m_socket;
@@ -91,7 +100,7 @@ protected:
     QByteArray m_buffer;
 
     Availability m_availability;
-    qint64 m_lastSeen;
+    qint64 m_lastSeen, m_updated;
 
     QJsonArray m_exposes;
     QJsonObject m_options;
@@ -106,6 +115,7 @@ protected:
     quint8 crc(const QByteArray &data);
 
     void updateAvailability(Availability available);
+    void updateProperties(const QMap <QString, QVariant> &properties);
     void sendFrame(quint8 type, const QByteArray &data);
 
 private slots:
@@ -120,11 +130,13 @@ private slots:
 
     void reset(void);
     void update(void);
+    void pollTimeout(void);
 
 signals:
 
     void availabilityUpdated(void);
     void propertiesUpdated(void);
+    void pollFinished(bool timeout);
 
 };
 
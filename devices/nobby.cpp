@@ -14,7 +14,7 @@ NobbyBalance::NobbyBalance(const QString &port, const QString &id, bool debug) :
     m_actions = {"status", "heater", "heaterTargetTemperature", "waterTargetTemperature"};
 }
 
-void NobbyBalance::action(const QString &name, const QVariant &data)
+bool NobbyBalance::action(const QString &name, const QVariant &data)
 {
     quint8 buffer[30];
     QByteArray payload;
@@ -29,7 +29,7 @@ void NobbyBalance::action(const QString &name, const QVariant &data)
             qint8 command = list.indexOf(data.toString());
 
             if (command < 0)
-                return;
+                return false;
 
             buffer[0] = command ? command : m_properties.value("status").toString() != "on" ? 0x01 : 0x02;
             buffer[1] = 0x01;
@@ -63,11 +63,12 @@ void NobbyBalance::action(const QString &name, const QVariant &data)
         }
 
         default:
-            return;
+            return false;
     }
 
     payload = QByteArray(reinterpret_cast <char*> (buffer), sizeof(buffer));
     sendFrame(FRAME_SET, payload.append(static_cast <char> (crc(payload))));
+    return true;
 }
 
 void NobbyBalance::parseFrame(quint8 type, const QByteArray &payload)
@@ -103,12 +104,7 @@ void NobbyBalance::parseFrame(quint8 type, const QByteArray &payload)
             properties.insert("pressure", static_cast <quint8> (payload.at(27)) / 10.0);
             properties.insert("errorCode", static_cast <quint8> (payload.at(6))); // not equals error codes on display
 
-            if (m_properties != properties)
-            {
-                m_properties = properties;
-                emit propertiesUpdated();
-            }
-
+            updateProperties(properties);
             break;
         }
     }
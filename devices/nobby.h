@@ -9,7 +9,7 @@ class NobbyBalance : public DeviceObject
 public:
 
     NobbyBalance(const QString &port, const QString &id, bool debug);
-    void action(const QString &name, const QVariant &data) override;
+    bool action(const QString &name, const QVariant &data) override;
 
 private:
 
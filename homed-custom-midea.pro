@@ -3,11 +3,13 @@ include(../homed-common/homed-common.pri)
 HEADERS += \
     controller.h \
     device.h \
-    devices/nobby.h
+    devices/nobby.h \
+    watchdog.h
 
 SOURCES += \
     controller.cpp \
     device.cpp \
-    devices/nobby.cpp
+    devices/nobby.cpp \
+    watchdog.cpp
 
 QT += serialport
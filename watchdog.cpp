@@ -0,0 +1,94 @@
+#include "watchdog.h"
+
+Watchdog *Watchdog::m_instance = nullptr;
+
+Watchdog::Watchdog(qint64 threshold, QObject *parent) : QObject(parent), m_timer(new QTimer(this)), m_threshold(threshold), m_last(0)
+{
+    connect(m_timer, &QTimer::timeout, this, &Watchdog::tick);
+
+    m_elapsed.start();
+    m_stall.duration = 0;
+
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->start(WATCHDOG_INTERVAL);
+
+    m_instance = this;
+}
+
+Watchdog::~Watchdog(void)
+{
+    if (m_instance == this)
+        m_instance = nullptr;
+}
+
+void Watchdog::enter(const QString &id, const QString &slot)
+{
+    m_stack.append({id, slot, {QString(), QString(), 0}});
+}
+
+void Watchdog::leave(qint64 duration)
+{
+    stallStruct stall;
+
+    if (m_stack.isEmpty())
+        return;
+
+    stall = m_stack.last().stall;
+
+    // keep nested handler attribution unless this handler blocked on its own
+
+    if (duration >= m_threshold && duration - stall.duration >= m_threshold)
+    {
+        QList <QString> list;
+
+        for (int i = 0; i < m_stack.count(); i++)
+            list.append(m_stack.at(i).slot);
+
+        stall = {m_stack.last().id, list.join('/'), duration};
+    }
+
+    m_stack.removeLast();
+
+    if (!stall.duration)
+        return;
+
+    if (!m_stack.isEmpty())
+    {
+        if (stall.duration > m_stack.last().stall.duration)
+            m_stack.last().stall = stall;
+
+        return;
+    }
+
+    if (stall.duration > m_stall.duration)
+        m_stall = stall;
+}
+
+void Watchdog::tick(void)
+{
+    qint64 now = m_elapsed.elapsed(), latency = m_last ? now - m_last - WATCHDOG_INTERVAL : 0;
+
+    m_last = now;
+
+    if (latency >= m_threshold || m_stall.duration >= m_threshold)
+        emit stallDetected(m_stall.id, m_stall.slot, m_stall.duration, latency);
+
+    m_stall = {QString(), QString(), 0};
+}
+
+WatchdogScope::WatchdogScope(const QString &id, const QString &slot)
+{
+    if (!Watchdog::instance())
+        return;
+
+    Watchdog::instance()->enter(id, slot);
+    m_timer.start();
+}
+
+WatchdogScope::~WatchdogScope(void)
+{
+    if (!Watchdog::instance() || !m_timer.isValid())
+        return;
+
+    Watchdog::instance()->leave(m_timer.elapsed());
+}
@@ -0,0 +1,74 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#define WATCHDOG_INTERVAL           100
+#define WATCHDOG_THRESHOLD          250
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+struct stallStruct
+{
+    QString id;
+    QString slot;
+    qint64 duration;
+};
+
+struct frameStruct
+{
+    QString id;
+    QString slot;
+    stallStruct stall;
+};
+
+class Watchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    Watchdog(qint64 threshold, QObject *parent);
+    ~Watchdog(void);
+
+    static Watchdog *instance(void) { return m_instance; }
+
+    void enter(const QString &id, const QString &slot);
+    void leave(qint64 duration);
+
+private:
+
+    static Watchdog *m_instance;
+
+    QTimer *m_timer;
+    QElapsedTimer m_elapsed;
+
+    qint64 m_threshold, m_last;
+
+    QList <frameStruct> m_stack;
+    stallStruct m_stall;
+
+private slots:
+
+    void tick(void);
+
+signals:
+
+    void stallDetected(const QString &id, const QString &slot, qint64 duration, qint64 latency);
+
+};
+
+class WatchdogScope
+{
+
+public:
+
+    WatchdogScope(const QString &id, const QString &slot);
+    ~WatchdogScope(void);
+
+private:
+
+    QElapsedTimer m_timer;
+
+};
+
+#endif